@@ -0,0 +1,255 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include <cmath>
+
+#include "graph.cpp"
+#include "graph_generators.h"
+
+//========================================================
+// Benchmark driver for Graph.
+// Usage: ./bench [--format csv|json] [--out FILE] [--scales a,b,c] [--min-ms N]
+//   --format: csv (default) or json
+//   --out: write results to FILE instead of stdout
+//   --scales: log2 vertex counts to run (default 8,10,12)
+//   --min-ms: minimum wall time spent per measurement (default 50)
+// Every generator is seeded, so two runs on the same scales measure the same graphs.
+//========================================================
+
+struct BenchResult {
+    string generator;
+    int vertices;
+    size_t edges;
+    string operation;
+    long long iterations;
+    double mean_ns;
+    double min_ns;
+    long long cache_hits;  // BFS cache hits during the measurement
+};
+
+struct BenchOptions {
+    string format = "csv";
+    string out = "";
+    vector<int> scales = {8, 10, 12};
+    double min_ms = 50.0;
+};
+
+// Discards everything written to it; used to keep print_path and bfs_tree output off the terminal
+class NullBuffer : public streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+};
+
+//========================================================
+// Function: time_operation
+// Purpose: Runs op repeatedly until at least minMs milliseconds and minIterations calls have passed.
+// Return: BenchResult with iteration count, mean and fastest single call in nanoseconds
+//========================================================
+
+BenchResult time_operation(const GraphSpec& spec, string operation, function<void()> op,
+                           double minMs, long long minIterations = 3)
+{
+    typedef chrono::steady_clock Clock;
+    BenchResult result = {spec.name, (int)spec.keys.size(), spec.edge_count(), operation, 0, 0.0, 0.0, 0};
+
+    double totalNs = 0.0;
+    double fastestNs = -1.0;
+    while (result.iterations < minIterations || totalNs < minMs * 1e6)
+    {
+        Clock::time_point start = Clock::now();
+        op();
+        double elapsed = chrono::duration<double, nano>(Clock::now() - start).count();
+
+        totalNs += elapsed;
+        if (fastestNs < 0 || elapsed < fastestNs) {
+            fastestNs = elapsed;
+        }
+        result.iterations++;
+    }
+
+    result.mean_ns = totalNs / result.iterations;
+    result.min_ns = fastestNs;
+    return result;
+}
+
+//========================================================
+// Function: time_cached
+// Purpose: Times a query that goes through the BFS cache, twice:
+//   - <operation>_cold: cache budget 0, so every call runs the traversal
+//   - <operation>_hot: default budget after one warm-up call, so every call is a cache hit
+// Both rows carry the number of cache hits seen while they were measured.
+//========================================================
+
+void time_cached(const GraphSpec& spec, Graph<int, int>& G, string operation, function<void()> op,
+                 double minMs, vector<BenchResult>& results)
+{
+    size_t budget = G.bfs_cache_stats().budget;
+
+    G.set_bfs_cache_budget(0);
+    long long hits = G.bfs_cache_stats().hits;
+    BenchResult cold = time_operation(spec, operation + "_cold", op, minMs);
+    cold.cache_hits = G.bfs_cache_stats().hits - hits;
+    results.push_back(cold);
+
+    G.set_bfs_cache_budget(budget);
+    op();
+    hits = G.bfs_cache_stats().hits;
+    BenchResult hot = time_operation(spec, operation + "_hot", op, minMs);
+    hot.cache_hits = G.bfs_cache_stats().hits - hits;
+    results.push_back(hot);
+}
+
+//========================================================
+// Function: bench_spec
+// Purpose: Times construction and every public query of Graph on one generated graph.
+//          Query endpoints are the first and last vertex plus a fixed set of random keys,
+//          so the same spec is always measured with the same workload.
+//========================================================
+
+void bench_spec(const GraphSpec& spec, const BenchOptions& options, vector<BenchResult>& results)
+{
+    int n = (int)spec.keys.size();
+    int first = spec.keys.front();
+    int last = spec.keys.back();
+
+    SplitRandom rng(42);
+    vector<int> probeKeys;
+    for (int i = 0; i < 64; ++i) {
+        probeKeys.push_back((int)rng.below(n));
+    }
+
+    results.push_back(time_operation(spec, "construct", [&]() {
+        Graph<int, int> G(spec.keys, spec.data, spec.adjs);
+    }, options.min_ms));
+
+    Graph<int, int> G(spec.keys, spec.data, spec.adjs);
+
+    // get is reported per lookup, not per batch of probe keys
+    BenchResult getResult = time_operation(spec, "get", [&]() {
+        for (int key : probeKeys) {
+            if (G.get(key) == nullptr) {
+                abort();
+            }
+        }
+    }, options.min_ms);
+    getResult.iterations *= probeKeys.size();
+    getResult.mean_ns /= probeKeys.size();
+    getResult.min_ns /= probeKeys.size();
+    results.push_back(getResult);
+
+    results.push_back(time_operation(spec, "bfs", [&]() { G.bfs(first); }, options.min_ms));
+    time_cached(spec, G, "reachable", [&]() { G.reachable(first, last); }, options.min_ms, results);
+
+    NullBuffer nullBuffer;
+    streambuf* prevbuf = cout.rdbuf(&nullBuffer);
+    time_cached(spec, G, "print_path", [&]() { G.print_path(first, last); }, options.min_ms, results);
+    time_cached(spec, G, "bfs_tree", [&]() { G.bfs_tree(first); }, options.min_ms, results);
+    cout.rdbuf(prevbuf);
+
+    // 256 queries from 8 sources; reported per query. It never uses the BFS cache, so it
+    // compares with reachable_cold
+    vector<pair<int, int>> batch;
+    for (int i = 0; i < 256; ++i) {
+        batch.push_back(make_pair(probeKeys[i % 8], (int)rng.below(n)));
+    }
+    BenchResult batchResult = time_operation(spec, "reachable_batch", [&]() { G.reachable_batch(batch); }, options.min_ms);
+    batchResult.iterations *= batch.size();
+    batchResult.mean_ns /= batch.size();
+    batchResult.min_ns /= batch.size();
+    results.push_back(batchResult);
+
+    int adjacent = spec.adjs[0].empty() ? last : spec.adjs[0].front();
+    results.push_back(time_operation(spec, "edge_class", [&]() { G.edge_class(first, adjacent); }, options.min_ms));
+}
+
+void write_csv(ostream& out, const vector<BenchResult>& results)
+{
+    out << "generator,vertices,edges,operation,iterations,mean_ns,min_ns,cache_hits" << endl;
+    for (const BenchResult& r : results) {
+        out << r.generator << "," << r.vertices << "," << r.edges << "," << r.operation << ","
+            << r.iterations << "," << (long long)r.mean_ns << "," << (long long)r.min_ns << ","
+            << r.cache_hits << endl;
+    }
+}
+
+void write_json(ostream& out, const vector<BenchResult>& results)
+{
+    out << "[" << endl;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "  {\"generator\": \"" << r.generator << "\", \"vertices\": " << r.vertices
+            << ", \"edges\": " << r.edges << ", \"operation\": \"" << r.operation
+            << "\", \"iterations\": " << r.iterations << ", \"mean_ns\": " << (long long)r.mean_ns
+            << ", \"min_ns\": " << (long long)r.min_ns << ", \"cache_hits\": " << r.cache_hits << "}" << (i + 1 < results.size() ? "," : "") << endl;
+    }
+    out << "]" << endl;
+}
+
+BenchOptions parse_options(int argc, char** argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            exit(1);
+        }
+        string value = argv[++i];
+        if (arg == "--format") {
+            options.format = value;
+        } else if (arg == "--out") {
+            options.out = value;
+        } else if (arg == "--min-ms") {
+            options.min_ms = atof(value.c_str());
+        } else if (arg == "--scales") {
+            options.scales.clear();
+            stringstream ss(value);
+            string scale;
+            while (getline(ss, scale, ',')) {
+                options.scales.push_back(atoi(scale.c_str()));
+            }
+        } else {
+            cerr << "Unknown option " << arg << endl;
+            exit(1);
+        }
+    }
+    if (options.format != "csv" && options.format != "json") {
+        cerr << "Unknown format " << options.format << " (expected csv or json)" << endl;
+        exit(1);
+    }
+    return options;
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options = parse_options(argc, argv);
+    vector<BenchResult> results;
+
+    for (int scale : options.scales) {
+        int n = 1 << scale;
+        int side = (int)sqrt((double)n);
+
+        bench_spec(generate_rmat(scale, 8), options, results);
+        bench_spec(generate_erdos_renyi(n, 8), options, results);
+        bench_spec(generate_grid(side), options, results);
+        bench_spec(generate_path(n), options, results);
+        cerr << "finished scale " << scale << endl;
+    }
+
+    ofstream outfile;
+    if (!options.out.empty()) {
+        outfile.open(options.out);
+    }
+    ostream& out = options.out.empty() ? cout : outfile;
+
+    if (options.format == "json") {
+        write_json(out, results);
+    } else {
+        write_csv(out, results);
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+#ifndef BFS_CACHE_H
+#define BFS_CACHE_H
+
+#include <vector>
+#include <list>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+
+using namespace std;
+
+//========================================================
+// Struct: BfsTree
+// Purpose: Compact result of one BFS, indexed by vertex position in the graph.
+//   - predecessor[v]: position of v's BFS parent, SOURCE for the source, UNREACHED otherwise
+//   - levelMembers: reached positions in BFS discovery order (so level by level)
+//   - levelStart[d]: offset in levelMembers where level d begins; the last entry is the end
+// Distances are not stored per vertex; level d is levelMembers[levelStart[d] .. levelStart[d+1]).
+//========================================================
+
+struct BfsTree {
+    static const int32_t SOURCE = -1;
+    static const int32_t UNREACHED = -2;
+
+    int source = 0;
+    vector<int32_t> predecessor;
+    vector<int32_t> levelMembers;
+    vector<int32_t> levelStart;
+
+    bool reached(int v) const { return predecessor[v] != UNREACHED; }
+    int levels() const { return (int)levelStart.size() - 1; }
+
+    // Upper bound on bytes() for a graph of vertexCount vertices (every vertex on its own level)
+    static size_t estimate_bytes(size_t vertexCount)
+    {
+        return sizeof(BfsTree) + sizeof(int32_t) * (3 * vertexCount + 1);
+    }
+
+    size_t bytes() const
+    {
+        return sizeof(BfsTree) + sizeof(int32_t) * (predecessor.capacity() + levelMembers.capacity() + levelStart.capacity());
+    }
+};
+
+//========================================================
+// Struct: BfsCacheStats
+// Purpose: Counters reported by BfsCache::stats.
+//   - invalidations: times the whole cache was dropped because the graph version changed
+//   - bytes / budget: memory held by cached trees and the most it may hold
+//   - index_bytes: approximate size of the graph's key index (key -> position map and adjacency
+//     as positions). It is filled in by Graph, lives as long as the graph and is not counted in
+//     bytes or limited by budget.
+//========================================================
+
+struct BfsCacheStats {
+    long long hits = 0;
+    long long misses = 0;
+    long long evictions = 0;
+    long long invalidations = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t budget = 0;
+    size_t index_bytes = 0;
+};
+
+//========================================================
+// Class: BfsCache
+// Purpose: Least-recently-used cache of BfsTrees keyed by source position, bounded by a byte
+//          budget. Every lookup carries the graph version; a version different from the one the
+//          entries were computed at empties the cache first.
+//========================================================
+
+class BfsCache {
+    public:
+        BfsCache(size_t budgetBytes) : budget(budgetBytes) {}
+
+        //========================================================
+        // Method: find
+        // Purpose: Looks up the tree for source and marks it most recently used.
+        // Return: the cached tree, or nullptr on a miss
+        //========================================================
+        shared_ptr<const BfsTree> find(int source, unsigned long graphVersion)
+        {
+            if (graphVersion != version) {
+                if (!entries.empty()) {
+                    counters.invalidations++;
+                }
+                clear();
+                version = graphVersion;
+            }
+
+            unordered_map<int, Entry>::iterator found = entries.find(source);
+            if (found == entries.end()) {
+                counters.misses++;
+                return nullptr;
+            }
+
+            counters.hits++;
+            recency.splice(recency.begin(), recency, found->second.position);
+            return found->second.tree;
+        }
+
+        //========================================================
+        // Method: insert
+        // Purpose: Stores a tree computed at graphVersion, evicting least recently used trees until
+        //          it fits. Trees larger than the whole budget are not stored.
+        //========================================================
+        void insert(shared_ptr<const BfsTree> tree, unsigned long graphVersion)
+        {
+            size_t size = tree->bytes();
+            if (graphVersion != version || size > budget || entries.count(tree->source)) {
+                return;
+            }
+
+            while (bytes + size > budget) {
+                evict();
+            }
+
+            recency.push_front(tree->source);
+            entries[tree->source] = Entry{tree, recency.begin()};
+            bytes += size;
+        }
+
+        void set_budget(size_t budgetBytes)
+        {
+            budget = budgetBytes;
+            while (bytes > budget) {
+                evict();
+            }
+        }
+
+        void clear()
+        {
+            entries.clear();
+            recency.clear();
+            bytes = 0;
+        }
+
+        BfsCacheStats stats() const
+        {
+            BfsCacheStats current = counters;
+            current.entries = entries.size();
+            current.bytes = bytes;
+            current.budget = budget;
+            return current;
+        }
+
+    private:
+        struct Entry {
+            shared_ptr<const BfsTree> tree;
+            list<int>::iterator position;
+        };
+
+        size_t budget;
+        size_t bytes = 0;
+        unsigned long version = 0;
+        list<int> recency;  // most recently used source first
+        unordered_map<int, Entry> entries;
+        BfsCacheStats counters;
+
+        void evict()
+        {
+            int source = recency.back();
+            bytes -= entries[source].tree->bytes();
+            entries.erase(source);
+            recency.pop_back();
+            counters.evictions++;
+        }
+};
+
+#endif
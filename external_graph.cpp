@@ -0,0 +1,359 @@
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include "external_graph.h"
+
+using namespace std;
+
+static const char EXTERNAL_MAGIC[8] = {'E', 'X', 'T', 'G', 'R', 'A', 'P', 'H'};
+static const uint64_t EXTERNAL_HEADER_BYTES = sizeof(EXTERNAL_MAGIC) + 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t);
+
+//========================================================
+// Constructor: ExternalGraphWriter
+// Purpose: Creates the file and reserves room for the header and block table, which are written
+//          by finish once every block's offset is known.
+// Parameters:
+//   - path: file to create; an existing file is overwritten
+//   - vertexCount: number of adjacency lists that will be added
+//   - blockVertices: vertices per block; a block is the unit read from disk
+// Postconditions:
+//   - Throws runtime_error if the file cannot be opened, blockVertices is 0 or vertexCount is
+//     above INT32_MAX (bfs stores vertex ids as int32 predecessors).
+//========================================================
+
+ExternalGraphWriter::ExternalGraphWriter(string path, uint64_t vertexCount, uint32_t blockVertices)
+    : out(path, ios::binary | ios::trunc), vertexCount(vertexCount), blockVertices(blockVertices)
+{
+    if (!out.is_open()) {
+        throw runtime_error("Cannot open " + path + " for writing");
+    }
+    if (blockVertices == 0) {
+        throw runtime_error("blockVertices must be positive");
+    }
+    if (vertexCount > INT32_MAX) {
+        throw runtime_error("Vertex ids must fit in 31 bits");
+    }
+
+    table.resize((vertexCount + blockVertices - 1) / blockVertices);
+    vector<char> reserved(EXTERNAL_HEADER_BYTES + table.size() * sizeof(ExternalBlock), 0);
+    out.write(reserved.data(), reserved.size());
+}
+
+ExternalGraphWriter::~ExternalGraphWriter()
+{
+    // An unfinished file has no header; it is left on disk for the caller to remove
+    if (out.is_open()) {
+        out.close();
+    }
+}
+
+//========================================================
+// Method: add_adjacency
+// Purpose: Appends the adjacency list of the next vertex (vertices are added in id order).
+// Parameters:
+//   - neighbours: ids of the vertex's out-neighbours, each below vertexCount
+// Postconditions:
+//   - Throws runtime_error if more than vertexCount lists are added, a neighbour id is out of
+//     range, or the writer is already finished.
+//========================================================
+
+void ExternalGraphWriter::add_adjacency(const vector<uint32_t>& adjacent)
+{
+    if (finished || written == vertexCount) {
+        throw runtime_error("More adjacency lists than vertices");
+    }
+    for (uint32_t v : adjacent) {
+        if (v >= vertexCount) {
+            throw runtime_error("Neighbour id out of range");
+        }
+    }
+
+    degrees.push_back((uint32_t)adjacent.size());
+    neighbours.insert(neighbours.end(), adjacent.begin(), adjacent.end());
+    edgeCount += adjacent.size();
+    written++;
+
+    if (degrees.size() == blockVertices) {
+        flush_block();
+    }
+}
+
+void ExternalGraphWriter::flush_block()
+{
+    ExternalBlock& block = table[(written - 1) / blockVertices];
+    block.offset = (uint64_t)out.tellp();
+    block.edges = neighbours.size();
+
+    out.write((const char*)degrees.data(), degrees.size() * sizeof(uint32_t));
+    out.write((const char*)neighbours.data(), neighbours.size() * sizeof(uint32_t));
+    degrees.clear();
+    neighbours.clear();
+}
+
+//========================================================
+// Method: finish
+// Purpose: Writes the last partial block, the header and the block table, and closes the file.
+// Postconditions:
+//   - Throws runtime_error if fewer than vertexCount lists were added or a write failed.
+//========================================================
+
+void ExternalGraphWriter::finish()
+{
+    if (finished) {
+        return;
+    }
+    if (written != vertexCount) {
+        throw runtime_error("Fewer adjacency lists than vertices");
+    }
+    if (!degrees.empty()) {
+        flush_block();
+    }
+
+    uint32_t blockCount = (uint32_t)table.size();
+    out.seekp(0);
+    out.write(EXTERNAL_MAGIC, sizeof(EXTERNAL_MAGIC));
+    out.write((const char*)&vertexCount, sizeof(vertexCount));
+    out.write((const char*)&edgeCount, sizeof(edgeCount));
+    out.write((const char*)&blockVertices, sizeof(blockVertices));
+    out.write((const char*)&blockCount, sizeof(blockCount));
+    out.write((const char*)table.data(), table.size() * sizeof(ExternalBlock));
+
+    if (!out) {
+        throw runtime_error("Write to external graph file failed");
+    }
+    out.close();
+    finished = true;
+}
+
+//========================================================
+// Constructor: ExternalGraph
+// Purpose: Opens a file written by ExternalGraphWriter and loads its header and block table.
+// Postconditions:
+//   - The block buffer is sized for the largest block; no adjacency is read yet.
+//   - Throws runtime_error if the file cannot be opened, is not an external graph file, has more
+//     than INT32_MAX vertices, or its block count, block table or edge count disagree with the header and the file size.
+//========================================================
+
+ExternalGraph::ExternalGraph(string path) : in(path, ios::binary)
+{
+    if (!in.is_open()) {
+        throw runtime_error("Cannot open " + path);
+    }
+
+    char magic[sizeof(EXTERNAL_MAGIC)];
+    uint32_t blockCount = 0;
+    in.read(magic, sizeof(magic));
+    in.read((char*)&vertexCount, sizeof(vertexCount));
+    in.read((char*)&edgeCount, sizeof(edgeCount));
+    in.read((char*)&blockVertices, sizeof(blockVertices));
+    in.read((char*)&blockCount, sizeof(blockCount));
+    if (!in || memcmp(magic, EXTERNAL_MAGIC, sizeof(magic)) != 0 || blockVertices == 0) {
+        throw runtime_error(path + " is not an external graph file");
+    }
+    if (vertexCount > INT32_MAX) {
+        throw runtime_error(path + " has more vertices than bfs can index");
+    }
+    // read_block computes each block's vertex count from this; a mismatch would underflow it
+    if (blockCount != (vertexCount + blockVertices - 1) / blockVertices) {
+        throw runtime_error(path + " has a block count that does not match its vertex count");
+    }
+
+    in.seekg(0, ios::end);
+    uint64_t fileBytes = (uint64_t)in.tellg();
+    uint64_t tableEnd = EXTERNAL_HEADER_BYTES + (uint64_t)blockCount * sizeof(ExternalBlock);
+    if (tableEnd > fileBytes) {
+        throw runtime_error(path + " has a truncated block table");
+    }
+    in.seekg(EXTERNAL_HEADER_BYTES);
+    table.resize(blockCount);
+    in.read((char*)table.data(), table.size() * sizeof(ExternalBlock));
+    if (!in) {
+        throw runtime_error(path + " has a truncated block table");
+    }
+
+    // Every block must lie between the table and the end of the file
+    uint64_t largest = 0;
+    uint64_t edges = 0;
+    for (uint32_t block = 0; block < blockCount; ++block) {
+        uint64_t count = min<uint64_t>(blockVertices, vertexCount - (uint64_t)block * blockVertices);
+        uint64_t available = table[block].offset < tableEnd || table[block].offset > fileBytes
+                                 ? 0 : (fileBytes - table[block].offset) / sizeof(uint32_t);
+        if (table[block].offset < tableEnd || count > available || table[block].edges > available - count) {
+            throw runtime_error(path + " has a block outside the file");
+        }
+        largest = max<uint64_t>(largest, table[block].edges);
+        edges += table[block].edges;
+    }
+    if (edges != edgeCount) {
+        throw runtime_error(path + " has block edge counts that do not add up to its edge count");
+    }
+    buffer.resize(blockVertices + largest);
+}
+
+//========================================================
+// Method: read_block
+// Purpose: Loads one block into the buffer and calls visit for each of its vertices.
+// Postconditions:
+//   - Throws runtime_error if the read fails, the block's degrees do not add up to its edge count
+//     or a neighbour id is not a vertex; visit is not called for any vertex of such a block.
+//========================================================
+
+void ExternalGraph::read_block(uint32_t block, Visitor visit)
+{
+    uint64_t first = (uint64_t)block * blockVertices;
+    uint32_t count = (uint32_t)min<uint64_t>(blockVertices, vertexCount - first);
+    uint64_t words = count + table[block].edges;
+
+    in.seekg(table[block].offset);
+    in.read((char*)buffer.data(), words * sizeof(uint32_t));
+    if (!in) {
+        throw runtime_error("Read of external graph block failed");
+    }
+    stats.blocks_read++;
+    stats.bytes_read += words * sizeof(uint32_t);
+
+    uint64_t degreeSum = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        degreeSum += buffer[i];
+    }
+    if (degreeSum != table[block].edges) {
+        throw runtime_error("External graph block degrees do not match its edge count");
+    }
+    for (uint64_t i = count; i < words; ++i) {
+        if (buffer[i] >= vertexCount) {
+            throw runtime_error("External graph block has a neighbour id out of range");
+        }
+    }
+
+    const uint32_t* adjacent = buffer.data() + count;
+    for (uint32_t i = 0; i < count; ++i) {
+        visit((uint32_t)(first + i), adjacent, buffer[i]);
+        adjacent += buffer[i];
+    }
+}
+
+//========================================================
+// Method: scan
+// Purpose: One sequential pass over the whole file, calling visit(vertex, neighbours, degree) for
+//          every vertex in id order. The neighbours pointer is only valid during the call.
+//========================================================
+
+void ExternalGraph::scan(Visitor visit)
+{
+    stats.passes++;
+    for (uint32_t block = 0; block < table.size(); ++block) {
+        read_block(block, visit);
+    }
+}
+
+//========================================================
+// Method: bfs
+// Purpose: Semi-external, level-synchronous breadth-first search. Each level is one forward pass
+//          over the file that reads only the blocks holding vertices of the current frontier.
+// Parameters:
+//   - source: start vertex id
+//   - distance: filled with each vertex's BFS distance, -1 if unreachable
+//   - predecessor: filled with each vertex's BFS parent, -1 for the source and unreached vertices
+// Preconditions:
+//   - source < vertex_count(); throws out_of_range otherwise.
+// Postconditions:
+//   - RAM used is the two output arrays plus one counter per block; passes equal the depth + 1.
+// Return: the largest distance reached
+//========================================================
+
+int ExternalGraph::bfs(uint32_t source, vector<int32_t>& distance, vector<int32_t>& predecessor)
+{
+    if (source >= vertexCount) {
+        throw out_of_range("BFS source is not a vertex");
+    }
+
+    distance.assign(vertexCount, -1);
+    predecessor.assign(vertexCount, -1);
+    vector<uint64_t> frontier(table.size(), 0);  // frontier vertices per block
+    vector<uint64_t> nextFrontier(table.size(), 0);
+
+    distance[source] = 0;
+    frontier[source / blockVertices] = 1;
+
+    int level = 0;
+    bool expanded = true;
+    while (expanded) {
+        expanded = false;
+        stats.passes++;
+        for (uint32_t block = 0; block < table.size(); ++block) {
+            if (frontier[block] == 0) {
+                continue;
+            }
+            read_block(block, [&](uint32_t u, const uint32_t* adjacent, uint32_t degree) {
+                if (distance[u] != level) {
+                    return;
+                }
+                for (uint32_t i = 0; i < degree; ++i) {
+                    uint32_t v = adjacent[i];
+                    if (distance[v] == -1) {
+                        distance[v] = level + 1;
+                        predecessor[v] = (int32_t)u;
+                        nextFrontier[v / blockVertices]++;
+                        expanded = true;
+                    }
+                }
+            });
+        }
+
+        frontier.swap(nextFrontier);
+        fill(nextFrontier.begin(), nextFrontier.end(), 0);
+        if (expanded) {
+            level++;
+        }
+    }
+
+    return level;
+}
+
+//========================================================
+// Method: connected_components
+// Purpose: Weakly connected components (edge direction ignored) in a single sequential pass,
+//          using an in-memory union-find over vertex ids.
+// Parameters:
+//   - component: filled with each vertex's component label, the smallest id in its component
+// Return: the number of components
+//========================================================
+
+uint64_t ExternalGraph::connected_components(vector<uint32_t>& component)
+{
+    component.resize(vertexCount);
+    for (uint64_t v = 0; v < vertexCount; ++v) {
+        component[v] = (uint32_t)v;
+    }
+
+    // Path halving; linking the larger root under the smaller keeps each root the component minimum
+    auto find = [&](uint32_t v) {
+        while (component[v] != v) {
+            component[v] = component[component[v]];
+            v = component[v];
+        }
+        return v;
+    };
+
+    scan([&](uint32_t u, const uint32_t* adjacent, uint32_t degree) {
+        for (uint32_t i = 0; i < degree; ++i) {
+            uint32_t a = find(u);
+            uint32_t b = find(adjacent[i]);
+            if (a < b) {
+                component[b] = a;
+            } else if (b < a) {
+                component[a] = b;
+            }
+        }
+    });
+
+    uint64_t components = 0;
+    for (uint64_t v = 0; v < vertexCount; ++v) {
+        component[v] = find((uint32_t)v);
+        if (component[v] == v) {
+            components++;
+        }
+    }
+    return components;
+}
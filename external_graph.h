@@ -0,0 +1,111 @@
+#ifndef EXTERNAL_GRAPH_H
+#define EXTERNAL_GRAPH_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <functional>
+
+using namespace std;
+
+//========================================================
+// External-memory graphs.
+// Adjacency lives in a block-partitioned file; only per-vertex state (distances, predecessors,
+// component labels) is kept in RAM, so graphs whose Vertex objects would not fit can still be
+// searched. Vertices are the dense ids 0..n-1, with n at most INT32_MAX so that bfs can store
+// every id in its int32 predecessor array.
+//
+// File layout (native byte order):
+//   header:  "EXTGRAPH", uint64 vertexCount, uint64 edgeCount, uint32 blockVertices, uint32 blockCount
+//   table:   per block, uint64 file offset and uint64 edge count
+//   blocks:  per block, uint32 degree of each of its vertices, then their neighbours in vertex order
+// Block b holds vertices [b * blockVertices, min(n, (b + 1) * blockVertices)).
+//========================================================
+
+struct ExternalBlock {
+    uint64_t offset = 0;
+    uint64_t edges = 0;
+};
+
+//========================================================
+// Class: ExternalGraphWriter
+// Purpose: Streams a graph to disk one adjacency list at a time. Only the block being filled is
+//          held in memory.
+// Usage:
+//   ExternalGraphWriter writer("big.extgraph", n);
+//   for each vertex 0..n-1 in order: writer.add_adjacency(neighbours);
+//   writer.finish();
+//========================================================
+
+class ExternalGraphWriter {
+    public:
+        ExternalGraphWriter(string path, uint64_t vertexCount, uint32_t blockVertices = 1 << 16);
+        ~ExternalGraphWriter();
+
+        void add_adjacency(const vector<uint32_t>& neighbours);
+        void finish();
+
+    private:
+        ofstream out;
+        uint64_t vertexCount;
+        uint32_t blockVertices;
+        uint64_t written = 0;      // vertices added so far
+        uint64_t edgeCount = 0;
+        bool finished = false;
+        vector<ExternalBlock> table;
+        vector<uint32_t> degrees;     // of the block being filled
+        vector<uint32_t> neighbours;  // of the block being filled
+
+        void flush_block();
+};
+
+//========================================================
+// Struct: ExternalScanStats
+// Purpose: I/O done by an ExternalGraph since it was opened or last reset.
+//   - passes: sequential sweeps over the file (a sweep may skip blocks it does not need)
+//   - blocks_read / bytes_read: blocks and bytes actually loaded from disk
+//========================================================
+
+struct ExternalScanStats {
+    long long passes = 0;
+    long long blocks_read = 0;
+    long long bytes_read = 0;
+};
+
+//========================================================
+// Class: ExternalGraph
+// Purpose: Read side of the file format above. Streams blocks through a single buffer the size
+//          of the largest block and runs semi-external BFS and connected components over them.
+//========================================================
+
+class ExternalGraph {
+    public:
+        typedef function<void(uint32_t vertex, const uint32_t* neighbours, uint32_t degree)> Visitor;
+
+        ExternalGraph(string path);
+
+        uint64_t vertex_count() const { return vertexCount; }
+        uint64_t edge_count() const { return edgeCount; }
+        uint32_t block_count() const { return (uint32_t)table.size(); }
+
+        void scan(Visitor visit);
+        int bfs(uint32_t source, vector<int32_t>& distance, vector<int32_t>& predecessor);
+        uint64_t connected_components(vector<uint32_t>& component);
+
+        const ExternalScanStats& scan_stats() const { return stats; }
+        void reset_scan_stats() { stats = ExternalScanStats(); }
+
+    private:
+        ifstream in;
+        uint64_t vertexCount = 0;
+        uint64_t edgeCount = 0;
+        uint32_t blockVertices = 0;
+        vector<ExternalBlock> table;
+        vector<uint32_t> buffer;
+        ExternalScanStats stats;
+
+        void read_block(uint32_t block, Visitor visit);
+};
+
+#endif
@@ -2,9 +2,14 @@
 #include <vector>
 #include <queue>
 #include <sstream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 
 #include "vertex.h"
 #include "graph.h"
+#include "graph_probe.h"
+#include "bfs_cache.h"
 
 using namespace std;
 //========================================================
@@ -23,33 +28,52 @@ using namespace std;
 // Return: None 
 //========================================================
 
-template <typename DataType, typename KeyType>
-Graph<DataType, KeyType>::Graph(vector<KeyType> vertexKeys, vector<DataType> vertexData, vector<vector<KeyType>> adjacencyLists)
+template <typename DataType, typename KeyType, typename Probe>
+Graph<DataType, KeyType, Probe>::Graph(vector<KeyType> vertexKeys, vector<DataType> vertexData, vector<vector<KeyType>> adjacencyLists)
+    : bfsCache(max((size_t)DEFAULT_BFS_CACHE_BYTES, (size_t)DEFAULT_BFS_CACHE_TREES * BfsTree::estimate_bytes(vertexKeys.size())))
 {
     Vertex<DataType, KeyType> *newVertex;
     for (int i = 0; i < vertexKeys.size(); ++i)
     {
         newVertex = new Vertex<DataType, KeyType>(vertexData[i], vertexKeys[i]); // Create a new vertex with data and key
-        newVertex->bfsProps.adjacencyList = adjacencyLists[i]; // Assign the adjacency list to the vertex's BFS properties
+        newVertex->adj = adjacencyLists[i]; // Assign the adjacency list to the vertex
         this->vertices.push_back(newVertex); // Add the new vertex to the graph's vertex list
     }
 }
 
+//========================================================
+// Destructor: ~Graph
+// Purpose: Releases the vertices allocated by the constructor.
+//========================================================
+
+template <typename DataType, typename KeyType, typename Probe>
+Graph<DataType, KeyType, Probe>::~Graph()
+{
+    for (Vertex<DataType, KeyType> *vertex : this->vertices)
+    {
+        delete vertex;
+    }
+}
+
 //========================================================
 // Method: get
 // Purpose: Retrieves a vertex from the graph based on the specified search key.
 // Parameters:
 //   - searchKey (KeyType)
 // Preconditions: None
-// Postconditions: None
+// Postconditions:
+//   - The vertex may be read and its data or search fields written, but its key and adjacency
+//     list must only change through add_edge. Editing `adj` directly leaves the key index and
+//     the BFS cache stale, with no signal.
 // Returns:
 //   - Vertex<DataType, KeyType>*: A pointer to the vertex with the matching key, if found.
 //   - nullptr: If no vertex with the specified key is found in the graph.
 //========================================================
 
-template <typename DataType, typename KeyType>
-Vertex<DataType, KeyType>* Graph<DataType, KeyType>::get(KeyType searchKey)
+template <typename DataType, typename KeyType, typename Probe>
+Vertex<DataType, KeyType>* Graph<DataType, KeyType, Probe>::get(KeyType searchKey)
 {
+    probe.lookup();
     for (int index = 0; index < vertices.size(); ++index)
     {
         if (vertices[index]->key == searchKey)
@@ -72,35 +96,43 @@ Vertex<DataType, KeyType>* Graph<DataType, KeyType>::get(KeyType searchKey)
 // Return: None
 //========================================================
 
-template <typename DataType, typename KeyType>
-void Graph<DataType, KeyType>::bfs(KeyType startKey)
+template <typename DataType, typename KeyType, typename Probe>
+void Graph<DataType, KeyType, Probe>::bfs(KeyType startKey)
 {
+    ProbeQuery<Probe> query(probe, "bfs");
     Vertex<DataType, KeyType> *nextVertex;
     queue<Vertex<DataType, KeyType> *> vertexQueue;
     Vertex<DataType, KeyType> *currentVertex = this->get(startKey);
 
     // Reset all vertices to default state
+    probe.begin_phase(PHASE_RESET);
     for (Vertex<DataType, KeyType> *vertex : this->vertices)
     {
         vertex->color = false;
         vertex->distance = -1;
         vertex->p = nullptr;
     }
+    probe.end_phase(PHASE_RESET);
+
+    probe.begin_phase(PHASE_TRAVERSAL);
 
     // Initialize the starting vertex
     currentVertex->color = true;
     currentVertex->distance = 0;
     currentVertex->p = nullptr;
     vertexQueue.push(currentVertex);
+    probe.discovered(0);
 
     while (!vertexQueue.empty())
     {
         currentVertex = vertexQueue.front();
         vertexQueue.pop();
+        probe.vertex_visited();
 
         // Process each adjacent vertex
         for (KeyType adjacentKey : currentVertex->adj)
         {
+            probe.edge_scanned();
             nextVertex = this->get(adjacentKey);
 
             if (!nextVertex->color)
@@ -109,9 +141,12 @@ void Graph<DataType, KeyType>::bfs(KeyType startKey)
                 nextVertex->distance = currentVertex->distance + 1;
                 nextVertex->p = currentVertex;
                 vertexQueue.push(nextVertex);
+                probe.discovered(nextVertex->distance);
             }
         }
     }
+
+    probe.end_phase(PHASE_TRAVERSAL);
 }
 
 
@@ -124,37 +159,49 @@ void Graph<DataType, KeyType>::bfs(KeyType startKey)
 // Pre-condition:
 //   - Both startKey and endKey must be valid vertex keys in the graph.
 // Post-condition:
-//   - Outputs the path from vertex `u` to vertex `v` if a path exists.
+//   - Outputs the path from vertex `u` to vertex `v` if a path exists; a path from a vertex to
+//     itself is printed as just its key.
 //   - If no path is found, prints a message indicating non-existence of a path.
+//   - The BFS tree of startKey is taken from the BFS cache when present; vertex BFS state is not modified.
 // Return: None
 //========================================================
 
-template <typename DataType, typename KeyType>
-void Graph<DataType, KeyType>::print_path(KeyType startKey, KeyType endKey)
+template <typename DataType, typename KeyType, typename Probe>
+void Graph<DataType, KeyType, Probe>::print_path(KeyType startKey, KeyType endKey)
 {
-    if (isReachable(startKey, endKey))
-        print_path(startKey, endKey, "");
+    ProbeQuery<Probe> query(probe, "print_path");
+    int startIndex = index_of(startKey);
+    int endIndex = index_of(endKey);
+    if (startIndex == -1 || endIndex == -1)
+    {
+        return;
+    }
+
+    shared_ptr<const BfsTree> tree = bfs_cached(startIndex);
+    if (tree->reached(endIndex))
+    {
+        ProbePhase<Probe> phase(probe, PHASE_REPORT);
+        print_path(*tree, endIndex, "");
+    }
 }
 
-template <typename DataType, typename KeyType>
-void Graph<DataType, KeyType>::print_path(KeyType startKey, KeyType endKey, string suffix)
+template <typename DataType, typename KeyType, typename Probe>
+void Graph<DataType, KeyType, Probe>::print_path(const BfsTree& tree, int endIndex, string suffix)
 {
-    Vertex<DataType, KeyType> *destinationVertex = this->get(endKey);
-
     stringstream output;
-    if (startKey == endKey)
+    if (endIndex == tree.source)
     {
-        output << startKey;
-        cout << output.str() << " -> ";
+        output << vertices[endIndex]->key;
+        cout << output.str() << suffix;  // " -> " when more of the path follows, nothing for a path to itself
     }
-    else if (destinationVertex->p == nullptr)
+    else if (tree.predecessor[endIndex] < 0)
     {
         cout << "No path available." << endl;
     }
     else
     {
-        print_path(startKey, destinationVertex->p->key, " -> ");
-        output << endKey;
+        print_path(tree, tree.predecessor[endIndex], " -> ");
+        output << vertices[endIndex]->key;
         cout << output.str() << suffix;
     }
     output.str("");  // Clear the contents of the stringstream
@@ -169,25 +216,28 @@ void Graph<DataType, KeyType>::print_path(KeyType startKey, KeyType endKey, stri
 // Preconditions:
 //   - Both `startKey` and `targetKey` should be valid keys of vertices within the graph.
 // Postconditions:
-//   - The method does not modify the graph but updates the visitation state of the vertices.
+//   - The method does not modify the graph or the visitation state of the vertices; the BFS tree of
+//     `startKey` is taken from (or added to) the BFS cache.
 //   - Returns a boolean indicating whether the target vertex is reachable from the start vertex.
 // Return:
 //   - true: If a path from `startKey` to `targetKey` exists.
 //   - false: If no such path exists or if either vertex key does not correspond to an existing vertex.
 //========================================================
 
-template <typename DataType, typename KeyType>
-bool Graph<DataType, KeyType>::reachable(KeyType startKey, KeyType targetKey)
+template <typename DataType, typename KeyType, typename Probe>
+bool Graph<DataType, KeyType, Probe>::reachable(KeyType startKey, KeyType targetKey)
 {
-    bfs(startKey);  // Perform BFS starting from startKey to mark all reachable vertices
-    Vertex<DataType, KeyType>* targetVertex = this->get(targetKey);
-    Vertex<DataType, KeyType>* startVertex = this->get(startKey);
+    ProbeQuery<Probe> query(probe, "reachable");
+    int targetIndex = index_of(targetKey);
+    int startIndex = index_of(startKey);
 
-    if (targetVertex == nullptr || startVertex == nullptr) {
+    if (targetIndex == -1 || startIndex == -1) {
         return false;  // Return false if either vertex does not exist, indicating one or both keys are invalid
     }
 
-    return targetVertex->color;  // Return the visited state of the target vertex, true if reachable, false otherwise
+    shared_ptr<const BfsTree> tree = bfs_cached(startIndex);  // BFS tree of startKey, run only on a cache miss
+
+    return tree->reached(targetIndex);  // true if the target was reached, false otherwise
 }
 
 //========================================================
@@ -199,54 +249,37 @@ bool Graph<DataType, KeyType>::reachable(KeyType startKey, KeyType targetKey)
 //   - `startKey` must be a valid key of a vertex within the graph. If not, the method may not function correctly.
 // Postconditions:
 //   - Outputs the BFS tree, showing vertices grouped by their depth levels.
-//   - Each depth level is printed on a new line.
+//   - Each depth level is printed on a new line, in the order BFS discovered its vertices (not
+//     graph order, which the original implementation used).
+//   - The BFS tree is taken from the BFS cache when present; vertex BFS state is not modified.
 // Return: None
 //========================================================
 
-template <typename DataType, typename KeyType>
-void Graph<DataType, KeyType>::bfs_tree(KeyType startKey)
+template <typename DataType, typename KeyType, typename Probe>
+void Graph<DataType, KeyType, Probe>::bfs_tree(KeyType startKey)
 {
-    vector<KeyType> verticesAtCurrentLevel;
-    int currentLevel = 0;
-    int maximumLevel = 0;
-
-    this->bfs(startKey);  // Perform BFS to set distances and determine tree structure
-
-    // Determine the maximum distance level from the start vertex
-    for (Vertex<DataType, KeyType> *vertex : this->vertices) {
-        if (vertex->distance > maximumLevel) {
-            maximumLevel = vertex->distance;
-        }
+    ProbeQuery<Probe> query(probe, "bfs_tree");
+    int startIndex = index_of(startKey);
+    if (startIndex == -1) {
+        return;
     }
 
-    // Loop through each level and gather vertices at that level
-    while (currentLevel <= maximumLevel) {
-        verticesAtCurrentLevel.clear();
-        for (Vertex<DataType, KeyType> *vertex : this->vertices) {
-            if (vertex->distance == currentLevel) {
-                verticesAtCurrentLevel.push_back(vertex->key);
-            }
-        }
-
-        // If no vertices at the current level, break the loop
-        if (verticesAtCurrentLevel.empty()) {
-            break;
-        }
+    shared_ptr<const BfsTree> tree = bfs_cached(startIndex);  // Levels of the BFS tree, run only on a cache miss
+    ProbePhase<Probe> phase(probe, PHASE_REPORT);
 
-        // Print all vertices at the current level
-        cout << verticesAtCurrentLevel.front();
-        for (KeyType key : verticesAtCurrentLevel) {
-            if (key != verticesAtCurrentLevel.front()) {
-                cout << " " << key;
+    // Print each level; levelMembers already lists every level's vertices in discovery order
+    for (int level = 0; level < tree->levels(); ++level) {
+        for (int member = tree->levelStart[level]; member < tree->levelStart[level + 1]; ++member) {
+            if (member != tree->levelStart[level]) {
+                cout << " ";
             }
+            cout << vertices[tree->levelMembers[member]]->key;
         }
 
         // Print newline unless it's the last level
-        if (currentLevel != maximumLevel) {
+        if (level + 1 != tree->levels()) {
             cout << endl;
         }
-
-        currentLevel++;
     }
 }
 
@@ -265,18 +298,20 @@ void Graph<DataType, KeyType>::bfs_tree(KeyType startKey)
 // Return: None
 //========================================================
 
-template <typename DataType, typename KeyType>
-void Graph<DataType, KeyType>::dfs_visit(Vertex<DataType, KeyType>* currentVertex, int* currentTime)
+template <typename DataType, typename KeyType, typename Probe>
+void Graph<DataType, KeyType, Probe>::dfs_visit(Vertex<DataType, KeyType>* currentVertex, int* currentTime)
 {
     (*currentTime)++; // Increment the global time counter
     currentVertex->discoveryTime = *currentTime; // Set the discovery time for the vertex
     currentVertex->visited = true; // Mark the vertex as visited
+    probe.vertex_visited();
 
     Vertex<DataType, KeyType>* adjacentVertex = nullptr;
 
     // Explore each adjacent vertex
     for (KeyType adjacentKey : currentVertex->adj)
     {
+        probe.edge_scanned();
         adjacentVertex = get(adjacentKey); // Retrieve the adjacent vertex
         if (!adjacentVertex->visited)
         {
@@ -303,15 +338,19 @@ void Graph<DataType, KeyType>::dfs_visit(Vertex<DataType, KeyType>* currentVerte
 // Return: None
 //========================================================
 
-template <typename DataType, typename KeyType>
-void Graph<DataType, KeyType>::dfs(KeyType startKey)
+template <typename DataType, typename KeyType, typename Probe>
+void Graph<DataType, KeyType, Probe>::dfs(KeyType startKey)
 {
     // Initialize all vertices
+    probe.begin_phase(PHASE_RESET);
     for (Vertex<DataType, KeyType>* vertex : this->vertices) {
         vertex->visited = false;
         vertex->predecessor = nullptr;
         vertex->discoveryTime = 0;
     }
+    probe.end_phase(PHASE_RESET);
+
+    probe.begin_phase(PHASE_TRAVERSAL);
 
     int* currentTime = new int(0);  // Using dynamic allocation to manage time during DFS
 
@@ -323,6 +362,7 @@ void Graph<DataType, KeyType>::dfs(KeyType startKey)
     }
 
     delete currentTime;  // Clean up the dynamically allocated time to prevent memory leaks
+    probe.end_phase(PHASE_TRAVERSAL);
 }
 
 
@@ -340,10 +380,12 @@ void Graph<DataType, KeyType>::dfs(KeyType startKey)
 //   - A string representing the type of edge: "tree edge", "back edge", "forward edge", "cross edge", or "no edge".
 //========================================================
 
-template <typename DataType, typename KeyType>
-string Graph<DataType, KeyType>::edge_class(KeyType startKey, KeyType endKey)
+template <typename DataType, typename KeyType, typename Probe>
+string Graph<DataType, KeyType, Probe>::edge_class(KeyType startKey, KeyType endKey)
 {
+    ProbeQuery<Probe> query(probe, "edge_class");
     dfs(startKey);  // Perform DFS to determine the structure of the graph and relationships
+    ProbePhase<Probe> phase(probe, PHASE_REPORT);
 
     Vertex<DataType, KeyType>* sourceVertex = get(startKey);
     Vertex<DataType, KeyType>* targetVertex = get(endKey);
@@ -390,3 +432,395 @@ string Graph<DataType, KeyType>::edge_class(KeyType startKey, KeyType endKey)
     return "cross edge";
 }
 
+//========================================================
+// Function: bfs_indexed
+// Purpose: Breadth-first search over an index-based copy of the adjacency lists. Unlike bfs, it
+//          writes into caller-owned arrays and leaves the vertices untouched, so several threads
+//          can run it on the same graph at once.
+// Parameters:
+//   - sourceIndex: position of the start vertex in `vertices`
+//   - adjacency: adjacency lists with neighbour keys replaced by their vertex positions
+//   - distance: filled with the BFS distance of each vertex, -1 if unreachable
+//   - predecessor: filled with the position of each vertex's BFS parent, -1 for none
+//   - trace: probe to report visits, edge scans and discoveries to; nullptr from worker threads
+//   - order: if given, filled with the reached positions in the order they were discovered
+// Return: None
+//========================================================
+
+template <typename DataType, typename KeyType, typename Probe>
+void Graph<DataType, KeyType, Probe>::bfs_indexed(int sourceIndex, const vector<vector<int>>& adjacency,
+                                                   vector<int>& distance, vector<int>& predecessor, Probe* trace,
+                                                   vector<int>* order) const
+{
+    distance.assign(adjacency.size(), -1);
+    predecessor.assign(adjacency.size(), -1);
+
+    vector<int> vertexQueue;
+    vertexQueue.reserve(adjacency.size());
+    distance[sourceIndex] = 0;
+    vertexQueue.push_back(sourceIndex);
+    if (trace) trace->discovered(0);
+
+    for (size_t head = 0; head < vertexQueue.size(); ++head)
+    {
+        int current = vertexQueue[head];
+        if (trace) trace->vertex_visited();
+        for (int next : adjacency[current])
+        {
+            if (trace) trace->edge_scanned();
+            if (distance[next] == -1)
+            {
+                distance[next] = distance[current] + 1;
+                predecessor[next] = current;
+                vertexQueue.push_back(next);
+                if (trace) trace->discovered(distance[next]);
+            }
+        }
+    }
+
+    if (order) order->swap(vertexQueue);
+}
+
+//========================================================
+// Function: index_graph
+// Purpose: Creates the key index on first use and brings it up to date with the current graph
+//          version. Rebuilt only after a change.
+// Preconditions:
+//   - KeyType is hashable (std::hash<KeyType> exists).
+// Postconditions:
+//   - Adjacency keys with no matching vertex are left out of keyIndex->adjacency.
+//   - A duplicated key maps to its first vertex, as in get.
+// Return: None
+//========================================================
+
+template <typename DataType, typename KeyType, typename Probe>
+void Graph<DataType, KeyType, Probe>::index_graph()
+{
+    if (keyIndex && keyIndex->version == version)
+    {
+        return;
+    }
+    if (!keyIndex)
+    {
+        keyIndex = unique_ptr<KeyIndex<KeyType>, void (*)(KeyIndex<KeyType>*)>(
+            new KeyIndex<KeyType>(), [](KeyIndex<KeyType>* index) { delete index; });
+    }
+
+    unordered_map<KeyType, int>& position = keyIndex->position;
+    vector<vector<int>>& indexedAdjacency = keyIndex->adjacency;
+    position.clear();
+    for (int i = 0; i < (int)vertices.size(); ++i)
+    {
+        position.emplace(vertices[i]->key, i);
+    }
+
+    indexedAdjacency.assign(vertices.size(), vector<int>());
+    for (int i = 0; i < (int)vertices.size(); ++i)
+    {
+        for (KeyType adjacentKey : vertices[i]->adj)
+        {
+            typename unordered_map<KeyType, int>::const_iterator found = position.find(adjacentKey);
+            if (found != position.end())
+            {
+                indexedAdjacency[i].push_back(found->second);
+            }
+        }
+    }
+
+    // Approximate footprint: hash nodes and buckets, plus the adjacency copy
+    size_t indexBytes = position.size() * (sizeof(KeyType) + sizeof(int) + 2 * sizeof(void*))
+               + position.bucket_count() * sizeof(void*)
+               + indexedAdjacency.size() * sizeof(vector<int>);
+    for (const vector<int>& adjacent : indexedAdjacency)
+    {
+        indexBytes += adjacent.capacity() * sizeof(int);
+    }
+
+    keyIndex->bytes = indexBytes;
+    keyIndex->version = version;
+}
+
+//========================================================
+// Function: index_of
+// Purpose: Resolves a key to its vertex position through the key index, in O(1) expected time
+//          instead of get's linear scan.
+// Parameters:
+//   - searchKey
+// Postconditions:
+//   - The key index is current.
+// Return: the position of the vertex with the key, or -1 if there is none
+//========================================================
+
+template <typename DataType, typename KeyType, typename Probe>
+int Graph<DataType, KeyType, Probe>::index_of(KeyType searchKey)
+{
+    index_graph();
+    typename unordered_map<KeyType, int>::const_iterator found = keyIndex->position.find(searchKey);
+    return found == keyIndex->position.end() ? -1 : found->second;
+}
+
+//========================================================
+// Function: bfs_cached
+// Purpose: Returns the BFS tree of a source from the BFS cache, running bfs_indexed and caching
+//          the encoded result on a miss.
+// Parameters:
+//   - sourceIndex: vertex position, as returned by index_of
+// Preconditions:
+//   - The key index is current (index_of was called at this version).
+// Postconditions:
+//   - Vertex BFS state is not modified.
+// Return: the tree; it stays valid after later evictions
+//========================================================
+
+template <typename DataType, typename KeyType, typename Probe>
+shared_ptr<const BfsTree> Graph<DataType, KeyType, Probe>::bfs_cached(int sourceIndex)
+{
+    shared_ptr<const BfsTree> cached = bfsCache.find(sourceIndex, version);
+    probe.cache_lookup(cached != nullptr);
+    if (cached)
+    {
+        return cached;
+    }
+
+    ProbePhase<Probe> phase(probe, PHASE_TRAVERSAL);
+    vector<int> distance;
+    vector<int> predecessor;
+    vector<int> order;
+    bfs_indexed(sourceIndex, keyIndex->adjacency, distance, predecessor, &probe, &order);
+
+    // Encode: predecessors as int32, distances as level ranges of the BFS queue. The queue is in
+    // discovery order, so its distances never decrease and each level is one contiguous range.
+    shared_ptr<BfsTree> tree = make_shared<BfsTree>();
+    tree->source = sourceIndex;
+    tree->predecessor.assign(predecessor.begin(), predecessor.end());
+    for (int i = 0; i < (int)distance.size(); ++i)
+    {
+        if (distance[i] == -1)
+        {
+            tree->predecessor[i] = BfsTree::UNREACHED;
+        }
+    }
+    tree->predecessor[sourceIndex] = BfsTree::SOURCE;
+
+    tree->levelMembers.assign(order.begin(), order.end());
+    for (int member = 0; member < (int)order.size(); ++member)
+    {
+        if (member == 0 || distance[order[member]] != distance[order[member - 1]])
+        {
+            tree->levelStart.push_back(member);
+        }
+    }
+    tree->levelStart.push_back((int32_t)order.size());
+    tree->levelStart.shrink_to_fit();
+
+    bfsCache.insert(tree, version);
+    return tree;
+}
+
+//========================================================
+// Function: add_edge
+// Purpose: Adds the directed edge (u, v) to the graph and bumps the graph version, which
+//          invalidates every cached BFS tree.
+// Parameters:
+//   - startKey
+//   - endKey
+// Return:
+//   - true: if the edge was added
+//   - false: if either key does not correspond to an existing vertex
+//========================================================
+
+template <typename DataType, typename KeyType, typename Probe>
+bool Graph<DataType, KeyType, Probe>::add_edge(KeyType startKey, KeyType endKey)
+{
+    Vertex<DataType, KeyType>* startVertex = this->get(startKey);
+    if (startVertex == nullptr || this->get(endKey) == nullptr)
+    {
+        return false;
+    }
+
+    startVertex->adj.push_back(endKey);
+    version++;
+    return true;
+}
+
+//========================================================
+// Function: set_bfs_cache_budget
+// Purpose: Sets the most memory, in bytes, the BFS cache may hold; 0 disables caching.
+//          Least recently used trees are evicted until the cache fits.
+//========================================================
+
+template <typename DataType, typename KeyType, typename Probe>
+void Graph<DataType, KeyType, Probe>::set_bfs_cache_budget(size_t bytes)
+{
+    bfsCache.set_budget(bytes);
+}
+
+//========================================================
+// Function: bfs_cache_stats
+// Purpose: Returns the BFS cache counters, with index_bytes set to the current size of the key
+//          index. The index is kept outside the cache budget, because every query needs it.
+//========================================================
+
+template <typename DataType, typename KeyType, typename Probe>
+BfsCacheStats Graph<DataType, KeyType, Probe>::bfs_cache_stats() const
+{
+    BfsCacheStats stats = bfsCache.stats();
+    stats.index_bytes = keyIndex ? keyIndex->bytes : 0;
+    return stats;
+}
+
+//========================================================
+// Function: batch_traverse
+// Purpose: Shared driver of the batch queries. Groups the queries by source vertex, runs one
+//          bfs_indexed per distinct source and hands every query of that source to `answer`.
+//          Source groups are spread across worker threads.
+// Parameters:
+//   - queries: (source key, target key) pairs
+//   - threads: number of worker threads; 0 uses the hardware concurrency
+//   - answer: called once per query whose keys both exist, with the query's position, the
+//             target's vertex position and the source's distance / predecessor arrays. Calls
+//             for different sources may run concurrently.
+// Preconditions:
+//   - KeyType is hashable.
+// Postconditions:
+//   - Vertex BFS state (color, distance, p) is not modified.
+//   - Queries with an unknown source or target key are never passed to `answer`.
+// Return: None
+//========================================================
+
+template <typename DataType, typename KeyType, typename Probe>
+void Graph<DataType, KeyType, Probe>::batch_traverse(const vector<pair<KeyType, KeyType>>& queries, unsigned threads,
+                                                     function<void(size_t, int, const vector<int>&, const vector<int>&)> answer)
+{
+    // Resolve keys to positions through the key index instead of once per get
+
+    // Group query positions by source, keeping the groups in order of first appearance
+    unordered_map<int, size_t> groupOf;
+    vector<int> groupSource;
+    vector<vector<pair<size_t, int>>> groups;  // (query position, target position)
+    for (size_t q = 0; q < queries.size(); ++q)
+    {
+        int source = index_of(queries[q].first);
+        int target = index_of(queries[q].second);
+        if (source == -1 || target == -1)
+        {
+            continue;
+        }
+
+        typename unordered_map<int, size_t>::iterator group = groupOf.find(source);
+        if (group == groupOf.end())
+        {
+            group = groupOf.emplace(source, groups.size()).first;
+            groupSource.push_back(source);
+            groups.push_back(vector<pair<size_t, int>>());
+        }
+        groups[group->second].push_back(make_pair(q, target));
+    }
+
+    if (threads == 0)
+    {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    threads = (unsigned)min<size_t>(threads, groups.size());
+
+    atomic<size_t> nextGroup(0);
+    auto worker = [&]() {
+        vector<int> distance;
+        vector<int> predecessor;
+        for (size_t g = nextGroup++; g < groups.size(); g = nextGroup++)
+        {
+            bfs_indexed(groupSource[g], keyIndex->adjacency, distance, predecessor);
+            for (const pair<size_t, int>& query : groups[g])
+            {
+                answer(query.first, query.second, distance, predecessor);
+            }
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; ++t)
+    {
+        workers.push_back(thread(worker));
+    }
+    worker();  // the calling thread takes a share of the groups too
+    for (thread& t : workers)
+    {
+        t.join();
+    }
+}
+
+//========================================================
+// Function: reachable_batch
+// Purpose: Answers many reachable(u, v) queries with one traversal per distinct source.
+// Parameters:
+//   - queries: (startKey, targetKey) pairs
+//   - threads: number of worker threads; 0 uses the hardware concurrency
+// Preconditions:
+//   - KeyType is hashable.
+// Postconditions:
+//   - Vertex BFS state is not modified (reachable does not modify it either).
+//   - The probe sees the batch as a single query; per-traversal counters are not reported.
+// Return:
+//   - One entry per query, in input order: true if a path exists, false if not or if either key
+//     does not correspond to an existing vertex.
+//========================================================
+
+template <typename DataType, typename KeyType, typename Probe>
+vector<bool> Graph<DataType, KeyType, Probe>::reachable_batch(const vector<pair<KeyType, KeyType>>& queries, unsigned threads)
+{
+    ProbeQuery<Probe> query(probe, "reachable_batch");
+    vector<char> found(queries.size(), 0);  // vector<bool> packs bits, so threads cannot share it
+
+    batch_traverse(queries, threads, [&](size_t q, int target, const vector<int>& distance, const vector<int>&) {
+        found[q] = distance[target] != -1;
+    });
+
+    return vector<bool>(found.begin(), found.end());
+}
+
+//========================================================
+// Function: path_batch
+// Purpose: Answers many print_path(u, v) queries with one traversal per distinct source, returning
+//          the paths instead of printing them.
+// Parameters:
+//   - queries: (startKey, endKey) pairs
+//   - threads: number of worker threads; 0 uses the hardware concurrency
+// Preconditions:
+//   - KeyType is hashable and can be written to an ostream.
+// Postconditions:
+//   - Vertex BFS state is not modified.
+//   - The probe sees the batch as a single query; per-traversal counters are not reported.
+// Return:
+//   - One entry per query, in input order: exactly what print_path would print for it
+//     ("T -> S -> R -> V", or "T" for T to itself), or an empty string if there is no path or
+//     either key is unknown.
+//========================================================
+
+template <typename DataType, typename KeyType, typename Probe>
+vector<string> Graph<DataType, KeyType, Probe>::path_batch(const vector<pair<KeyType, KeyType>>& queries, unsigned threads)
+{
+    ProbeQuery<Probe> query(probe, "path_batch");
+    vector<string> paths(queries.size());
+
+    batch_traverse(queries, threads, [&](size_t q, int target, const vector<int>& distance, const vector<int>& predecessor) {
+        if (distance[target] == -1)
+        {
+            return;
+        }
+
+        vector<int> route;
+        for (int current = target; current != -1; current = predecessor[current])
+        {
+            route.push_back(current);
+        }
+
+        stringstream output;
+        for (size_t i = route.size(); i-- > 0;)
+        {
+            output << vertices[route[i]]->key << (i > 0 ? " -> " : "");
+        }
+        paths[q] = output.str();
+    });
+
+    return paths;
+}
@@ -3,28 +3,80 @@
 
 #include <vector>
 #include <string>
+#include <utility>
+#include <functional>
+#include <unordered_map>
+#include <memory>
 
 #include "vertex.h"
+#include "graph_probe.h"
+#include "bfs_cache.h"
 
 using namespace std;
 
-template <typename D, typename K>
+// Key index used by reachable, print_path, bfs_tree and the batch queries: key -> vertex position
+// and the adjacency lists as positions. Graph holds it through a pointer with a plain function
+// deleter, so KeyIndex<K> (and std::hash<K>) is only instantiated by code that calls those queries.
+template <typename K>
+struct KeyIndex {
+    unsigned long version = 0;
+    size_t bytes = 0;
+    unordered_map<K,int> position;
+    vector<vector<int>> adjacency;
+};
+
+// Probe receives hot-path events (lookups, visits, edge scans, phase times); see graph_probe.h.
+// The default NoProbe compiles every hook away.
+// K needs operator==. reachable, print_path, bfs_tree and the batch queries also need std::hash<K>.
+template <typename D, typename K, typename Probe = NoProbe>
 class Graph {
     public:
         Graph(vector<K> keys, vector<D> data, vector<vector<K>> edges);
+        ~Graph();
+        // The graph owns its vertices, so copies would share and double-delete them
+        Graph(const Graph&) = delete;
+        Graph& operator=(const Graph&) = delete;
         Vertex<D,K>* get(K key);
         bool reachable(K u, K v);
         void print_path(K u, K v);
         string edge_class(K u, K v);
         void bfs(K s);
         void bfs_tree(K s);
+        vector<bool> reachable_batch(const vector<pair<K,K>>& queries, unsigned threads = 0);
+        vector<string> path_batch(const vector<pair<K,K>>& queries, unsigned threads = 0);
+        bool add_edge(K u, K v);
+        void set_bfs_cache_budget(size_t bytes);
+        BfsCacheStats bfs_cache_stats() const;
+        Probe& get_probe() { return probe; }
+
+        // The default cache budget holds DEFAULT_BFS_CACHE_TREES full trees, and never less than
+        // DEFAULT_BFS_CACHE_BYTES
+        static const size_t DEFAULT_BFS_CACHE_BYTES = 8 << 20;
+        static const size_t DEFAULT_BFS_CACHE_TREES = 16;
 
     private:
         vector<Vertex<D,K>*> vertices;
         vector<vector<K>> edges;
-        void print_path(K u, K v, string suff);
+        Probe probe;
+
+        // Bumped by add_edge; cached BFS trees and the key index are tied to it
+        unsigned long version = 0;
+        BfsCache bfsCache;
+
+        // Built on the first indexed query and kept for the graph's lifetime; it is not part of the
+        // BFS cache budget (see bfs_cache_stats)
+        unique_ptr<KeyIndex<K>, void (*)(KeyIndex<K>*)> keyIndex{nullptr, nullptr};
+
+        void print_path(const BfsTree& tree, int v, string suff);
         void dfs(K s);
         void dfs_visit(Vertex<D,K>* u, int* time);
+        void bfs_indexed(int s, const vector<vector<int>>& adj, vector<int>& distance, vector<int>& predecessor,
+                         Probe* trace = nullptr, vector<int>* order = nullptr) const;
+        void index_graph();
+        int index_of(K key);
+        shared_ptr<const BfsTree> bfs_cached(int s);
+        void batch_traverse(const vector<pair<K,K>>& queries, unsigned threads,
+                            function<void(size_t, int, const vector<int>&, const vector<int>&)> answer);
 };
 
 #endif
@@ -0,0 +1,181 @@
+#ifndef GRAPH_GENERATORS_H
+#define GRAPH_GENERATORS_H
+
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdint>
+
+using namespace std;
+
+//========================================================
+// Struct: GraphSpec
+// Purpose: Holds the three vectors the Graph constructor expects, so a generated graph can be
+//          built (and rebuilt) without regenerating it.
+//   - keys: vertex keys 0..n-1
+//   - data: per-vertex payload (key + 100, same convention as test_graph.cpp)
+//   - adjs: directed adjacency list of each vertex
+//========================================================
+
+struct GraphSpec {
+    string name;
+    vector<int> keys;
+    vector<int> data;
+    vector<vector<int>> adjs;
+
+    size_t edge_count() const
+    {
+        size_t total = 0;
+        for (const vector<int>& adj : adjs) {
+            total += adj.size();
+        }
+        return total;
+    }
+};
+
+//========================================================
+// Class: SplitRandom
+// Purpose: Small deterministic random source for the generators. The standard distributions are
+//          implementation-defined, so values are derived from the raw mt19937_64 stream to keep the
+//          generated graphs identical across compilers and platforms.
+//========================================================
+
+class SplitRandom {
+    public:
+        SplitRandom(uint64_t seed) : engine(seed) {}
+
+        // Uniform integer in [0, bound)
+        uint64_t below(uint64_t bound) { return engine() % bound; }
+
+        // Uniform double in [0, 1)
+        double unit() { return (engine() >> 11) * (1.0 / 9007199254740992.0); }
+
+    private:
+        mt19937_64 engine;
+};
+
+//========================================================
+// Function: make_empty_spec
+// Purpose: Creates a spec with n vertices, keys 0..n-1 and no edges.
+//========================================================
+
+inline GraphSpec make_empty_spec(string name, int vertexCount)
+{
+    GraphSpec spec;
+    spec.name = name;
+    spec.adjs.resize(vertexCount);
+    for (int i = 0; i < vertexCount; ++i) {
+        spec.keys.push_back(i);
+        spec.data.push_back(i + 100);
+    }
+    return spec;
+}
+
+//========================================================
+// Function: generate_rmat
+// Purpose: Generates an R-MAT (recursive Kronecker) graph with 2^scale vertices and
+//          edgeFactor * 2^scale directed edges, using the Graph500 quadrant probabilities.
+// Parameters:
+//   - scale: log2 of the vertex count
+//   - edgeFactor: average out-degree
+//   - seed: random seed; equal seeds give equal graphs
+// Return: GraphSpec with self loops dropped (duplicate edges are kept, as in Graph500)
+//========================================================
+
+inline GraphSpec generate_rmat(int scale, int edgeFactor, uint64_t seed = 1)
+{
+    const double a = 0.57, b = 0.19, c = 0.19;
+    int vertexCount = 1 << scale;
+    GraphSpec spec = make_empty_spec("rmat", vertexCount);
+    SplitRandom rng(seed);
+
+    long long edgeCount = (long long)edgeFactor * vertexCount;
+    for (long long e = 0; e < edgeCount; ++e) {
+        int u = 0, v = 0;
+        for (int bit = 0; bit < scale; ++bit) {
+            double r = rng.unit();
+            if (r < a) {
+                // top-left quadrant: neither bit set
+            } else if (r < a + b) {
+                v |= 1 << bit;
+            } else if (r < a + b + c) {
+                u |= 1 << bit;
+            } else {
+                u |= 1 << bit;
+                v |= 1 << bit;
+            }
+        }
+        if (u != v) {
+            spec.adjs[u].push_back(v);
+        }
+    }
+    return spec;
+}
+
+//========================================================
+// Function: generate_erdos_renyi
+// Purpose: Generates a G(n, m) Erdos-Renyi graph: m directed edges with endpoints drawn uniformly.
+// Parameters:
+//   - vertexCount
+//   - averageDegree: m = averageDegree * vertexCount
+//   - seed
+// Return: GraphSpec without self loops
+//========================================================
+
+inline GraphSpec generate_erdos_renyi(int vertexCount, int averageDegree, uint64_t seed = 1)
+{
+    GraphSpec spec = make_empty_spec("erdos_renyi", vertexCount);
+    SplitRandom rng(seed);
+
+    long long edgeCount = (long long)averageDegree * vertexCount;
+    for (long long e = 0; e < edgeCount; ++e) {
+        int u = (int)rng.below(vertexCount);
+        int v = (int)rng.below(vertexCount);
+        if (u != v) {
+            spec.adjs[u].push_back(v);
+        }
+    }
+    return spec;
+}
+
+//========================================================
+// Function: generate_grid
+// Purpose: Generates a side x side 4-connected grid with edges in both directions.
+//          Vertex (row, col) has key row * side + col.
+//========================================================
+
+inline GraphSpec generate_grid(int side)
+{
+    GraphSpec spec = make_empty_spec("grid", side * side);
+    for (int row = 0; row < side; ++row) {
+        for (int col = 0; col < side; ++col) {
+            int key = row * side + col;
+            if (col + 1 < side) {
+                spec.adjs[key].push_back(key + 1);
+                spec.adjs[key + 1].push_back(key);
+            }
+            if (row + 1 < side) {
+                spec.adjs[key].push_back(key + side);
+                spec.adjs[key + side].push_back(key);
+            }
+        }
+    }
+    return spec;
+}
+
+//========================================================
+// Function: generate_path
+// Purpose: Generates a directed path 0 -> 1 -> ... -> n-1, the worst case for BFS depth and
+//          for the recursive DFS used by edge_class.
+//========================================================
+
+inline GraphSpec generate_path(int vertexCount)
+{
+    GraphSpec spec = make_empty_spec("path", vertexCount);
+    for (int i = 0; i + 1 < vertexCount; ++i) {
+        spec.adjs[i].push_back(i + 1);
+    }
+    return spec;
+}
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef GRAPH_PROBE_H
+#define GRAPH_PROBE_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+using namespace std;
+
+//========================================================
+// Instrumentation policies for Graph.
+// Graph takes a Probe template parameter and reports its hot-path events to it:
+//   - begin_query / end_query: one public call (reachable, edge_class, ...); nested calls made
+//     by that method count toward the outermost query. A bare call to get is not a query; its
+//     lookup is discarded when the next query begins and never reaches last_query or totals.
+//   - begin_phase / end_phase: reset, traversal and report sections of a query
+//   - lookup: one call to get
+//   - vertex_visited: a vertex dequeued by bfs or entered by dfs_visit (batch queries traverse on
+//     worker threads and report no visits, edge scans or discoveries)
+//   - edge_scanned: one adjacency entry examined
+//   - discovered: a vertex first reached at the given BFS level
+//   - cache_lookup: a BFS cache lookup, and whether it hit
+// NoProbe is the default; every hook is an empty inline function, so Graph<D,K> compiles to the
+// uninstrumented code. CountingProbe records per-query and aggregate statistics.
+//========================================================
+
+enum GraphPhase {
+    PHASE_RESET,      // clearing per-vertex search state
+    PHASE_TRAVERSAL,  // the bfs / dfs itself
+    PHASE_REPORT,     // building the answer from search state (paths, levels, edge classes)
+    PHASE_COUNT
+};
+
+struct NoProbe {
+    void begin_query(const char*) {}
+    void end_query() {}
+    void begin_phase(GraphPhase) {}
+    void end_phase(GraphPhase) {}
+    void lookup() {}
+    void vertex_visited() {}
+    void edge_scanned() {}
+    void discovered(int) {}
+    void cache_lookup(bool) {}
+};
+
+//========================================================
+// Struct: QueryStats
+// Purpose: Counters for one query, or summed over many queries.
+//   - frontier_sizes[level]: number of vertices discovered at that BFS level
+//   - phase_ns[phase]: wall time spent in each GraphPhase, in nanoseconds
+//========================================================
+
+struct QueryStats {
+    string query;
+    long long vertices_visited = 0;
+    long long edges_scanned = 0;
+    long long lookups = 0;
+    long long cache_hits = 0;
+    long long cache_misses = 0;
+    vector<long long> frontier_sizes;
+    double phase_ns[PHASE_COUNT] = {};
+};
+
+//========================================================
+// Class: CountingProbe
+// Purpose: Probe policy that counts every hot-path event.
+//   - last_query(): statistics of the most recently finished query
+//   - totals(): statistics summed over every finished query since the last reset
+//   - query_count(): number of finished queries since the last reset
+//========================================================
+
+class CountingProbe {
+    public:
+        void begin_query(const char* name)
+        {
+            if (depth++ == 0) {
+                current = QueryStats();
+                current.query = name;
+            }
+        }
+
+        void end_query()
+        {
+            if (--depth == 0) {
+                accumulate(current);
+                last = current;
+                queries++;
+            }
+        }
+
+        void begin_phase(GraphPhase phase) { phaseStart[phase] = Clock::now(); }
+
+        void end_phase(GraphPhase phase)
+        {
+            current.phase_ns[phase] += chrono::duration<double, nano>(Clock::now() - phaseStart[phase]).count();
+        }
+
+        void lookup() { current.lookups++; }
+        void vertex_visited() { current.vertices_visited++; }
+        void edge_scanned() { current.edges_scanned++; }
+        void cache_lookup(bool hit) { (hit ? current.cache_hits : current.cache_misses)++; }
+
+        void discovered(int level)
+        {
+            if ((int)current.frontier_sizes.size() <= level) {
+                current.frontier_sizes.resize(level + 1, 0);
+            }
+            current.frontier_sizes[level]++;
+        }
+
+        const QueryStats& last_query() const { return last; }
+        const QueryStats& totals() const { return total; }
+        long long query_count() const { return queries; }
+
+        void reset()
+        {
+            last = QueryStats();
+            total = QueryStats();
+            queries = 0;
+        }
+
+    private:
+        typedef chrono::steady_clock Clock;
+
+        QueryStats current;
+        QueryStats last;
+        QueryStats total;
+        long long queries = 0;
+        int depth = 0;
+        Clock::time_point phaseStart[PHASE_COUNT];
+
+        void accumulate(const QueryStats& stats)
+        {
+            total.vertices_visited += stats.vertices_visited;
+            total.edges_scanned += stats.edges_scanned;
+            total.lookups += stats.lookups;
+            total.cache_hits += stats.cache_hits;
+            total.cache_misses += stats.cache_misses;
+            if (total.frontier_sizes.size() < stats.frontier_sizes.size()) {
+                total.frontier_sizes.resize(stats.frontier_sizes.size(), 0);
+            }
+            for (size_t level = 0; level < stats.frontier_sizes.size(); ++level) {
+                total.frontier_sizes[level] += stats.frontier_sizes[level];
+            }
+            for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+                total.phase_ns[phase] += stats.phase_ns[phase];
+            }
+        }
+};
+
+//========================================================
+// Scope guards used inside Graph so that every return path closes its query or phase.
+//========================================================
+
+template <typename Probe>
+class ProbeQuery {
+    public:
+        ProbeQuery(Probe& p, const char* name) : probe(p) { probe.begin_query(name); }
+        ~ProbeQuery() { probe.end_query(); }
+
+    private:
+        Probe& probe;
+};
+
+template <typename Probe>
+class ProbePhase {
+    public:
+        ProbePhase(Probe& p, GraphPhase ph) : probe(p), phase(ph) { probe.begin_phase(phase); }
+        ~ProbePhase() { probe.end_phase(phase); }
+
+    private:
+        Probe& probe;
+        GraphPhase phase;
+};
+
+#endif
@@ -1,10 +1,14 @@
 #include <fstream>
 #include <sstream>
+#include <cstdio>
 #include "graph.cpp"
+#include "external_graph.h"
+#include "graph_generators.h"
 #include <sstream>
 
 // TODO: Get all other test cases running and uncommented.
-Graph<string, string>* generate_graph(string fname){
+template <typename Probe = NoProbe>
+Graph<string, string, Probe>* generate_graph(string fname){
     string line;
     ifstream infile(fname);
     vector<string> keys = {};
@@ -29,7 +33,7 @@ Graph<string, string>* generate_graph(string fname){
             adjs.push_back(adj_lst);
         }
     }
-    Graph<string,string>* G = new Graph<string, string>(keys, data, adjs);
+    Graph<string,string,Probe>* G = new Graph<string, string, Probe>(keys, data, adjs);
     return G;
 }
 
@@ -285,9 +289,295 @@ void test_edge_class_int(Graph<int,int>* G) {
     }
 
 }
+void test_probe() {
+    try {
+        Graph<string, string, CountingProbe>* G = generate_graph<CountingProbe>("graph_description.txt");
+        G->reachable("T", "V");
+        const QueryStats& stats = G->get_probe().last_query();
+        vector<long long> frontiers = {1, 3, 3, 1};
+        if(stats.query != "reachable" || stats.vertices_visited != 8 || stats.edges_scanned != 10 || stats.lookups != 0) {
+            cout << "Incorrect probe counters for reachable(\"T\", \"V\"). Expected 8 visited, 10 scanned, 0 lookups but got : "
+                 << stats.vertices_visited << ", " << stats.edges_scanned << ", " << stats.lookups << endl;
+        }
+        if(stats.frontier_sizes != frontiers) {
+            cout << "Incorrect probe frontier sizes for reachable(\"T\", \"V\"). Expected 1 3 3 1" << endl;
+        }
+        G->edge_class("R", "V");
+        if(G->get_probe().query_count() != 2 || G->get_probe().totals().vertices_visited != 16) {
+            cout << "Incorrect probe totals after two queries. Expected 2 queries and 16 visited but got : "
+                 << G->get_probe().query_count() << ", " << G->get_probe().totals().vertices_visited << endl;
+        }
+        delete G;
+    } catch(exception& e) {
+        cerr << "Error testing probe : " << e.what() << endl;
+    }
+}
+
+void test_batch(Graph<string,string>* G) {
+    try {
+        vector<pair<string, string>> queries = {{"T", "V"}, {"R", "V"}, {"T", "Y"}, {"S", "A"}, {"R", "T"}, {"T", "T"}};
+        vector<bool> reach = G->reachable_batch(queries, 2);
+        vector<bool> expectedReach = {true, true, true, false, false, true};
+        if(reach != expectedReach) {
+            cout << "Incorrect reachable_batch results" << endl;
+        }
+        vector<string> paths = G->path_batch(queries, 2);
+        vector<string> expectedPaths = {"T -> S -> R -> V", "R -> V", "T -> U -> Y", "", "", "T"};
+        for(size_t i = 0; i < queries.size(); i++) {
+            if(paths[i] != expectedPaths[i]) {
+                cout << "Incorrect path_batch result " << i << ". Expected: " << expectedPaths[i] << " but got : " << paths[i] << endl;
+            }
+            stringstream buffer;
+            streambuf* prevbuf = cout.rdbuf(buffer.rdbuf());
+            G->print_path(queries[i].first, queries[i].second);
+            cout.rdbuf(prevbuf);
+            if(paths[i] != buffer.str()) {
+                cout << "path_batch result " << i << " differs from print_path. Expected: " << buffer.str() << " but got : " << paths[i] << endl;
+            }
+        }
+    } catch(exception& e) {
+        cerr << "Error testing batch queries : " << e.what() << endl;
+    }
+}
+
+void test_batch_int(Graph<int,int>* G) {
+    try {
+        vector<pair<int, int>> queries = {{1, 4}, {2, 6}, {3, 5}, {2, 3}, {1, 3}};
+        vector<bool> reach = G->reachable_batch(queries);
+        vector<bool> expectedReach = {true, false, false, true, true};
+        if(reach != expectedReach) {
+            cout << "Incorrect reachable_batch results for int graph" << endl;
+        }
+        vector<string> paths = G->path_batch(queries);
+        if(paths[0] != "1 -> 2 -> 4" || paths[3] != "2 -> 3" || paths[1] != "") {
+            cout << "Incorrect path_batch results for int graph. Expected: 1 -> 2 -> 4 but got : " << paths[0] << endl;
+        }
+    } catch(exception& e) {
+        cerr << "Error testing batch queries : " << e.what() << endl;
+    }
+}
+
+void test_bfs_cache() {
+    try {
+        Graph<string, string>* G = generate_graph("graph_description.txt");
+        stringstream buffer;
+        streambuf* prevbuf = cout.rdbuf(buffer.rdbuf());
+        G->print_path("T", "V");
+        G->bfs_tree("T");
+        cout.rdbuf(prevbuf);
+        BfsCacheStats stats = G->bfs_cache_stats();
+        if(stats.misses != 1 || stats.hits != 1 || stats.entries != 1) {
+            cout << "Incorrect BFS cache stats. Expected 1 miss, 1 hit, 1 entry but got : "
+                 << stats.misses << ", " << stats.hits << ", " << stats.entries << endl;
+        }
+        if(stats.index_bytes == 0 || stats.budget < Graph<string, string>::DEFAULT_BFS_CACHE_TREES * BfsTree::estimate_bytes(8)) {
+            cout << "Incorrect BFS cache sizing. Expected a key index and room for the default number of trees" << endl;
+        }
+
+        // R -> T is not in the graph until the edge is added; the cached tree of R must be dropped
+        if(G->reachable("R", "T")) {
+            cout << "Incorrectly identified \"T\" as reachable from \"R\"" << endl;
+        }
+        G->add_edge("V", "T");
+        if(!G->reachable("R", "T")) {
+            cout << "Stale BFS cache: \"T\" should be reachable from \"R\" after adding edge (\"V\", \"T\")" << endl;
+        }
+        if(G->bfs_cache_stats().invalidations != 1) {
+            cout << "Incorrect BFS cache invalidations. Expected 1 but got : " << G->bfs_cache_stats().invalidations << endl;
+        }
+
+        // A budget that fits one tree but not two keeps only the most recently used source
+        G->set_bfs_cache_budget(G->bfs_cache_stats().bytes * 3 / 2);
+        G->reachable("S", "V");
+        G->reachable("R", "V");
+        stats = G->bfs_cache_stats();
+        if(stats.entries != 1 || stats.evictions < 1 || stats.bytes > stats.budget) {
+            cout << "Incorrect BFS cache eviction. Expected 1 entry within budget but got : "
+                 << stats.entries << " entries, " << stats.bytes << " bytes" << endl;
+        }
+        delete G;
+    } catch(exception& e) {
+        cerr << "Error testing BFS cache : " << e.what() << endl;
+    }
+}
+
+// Key type with equality but no std::hash; Graph must still construct and answer the queries that
+// do not use the key index
+struct PlainKey {
+    int id;
+    bool operator==(const PlainKey& other) const { return id == other.id; }
+};
+
+void test_unhashable_key() {
+    try {
+        vector<PlainKey> keys = {{1}, {2}, {3}};
+        vector<int> data = {10, 20, 30};
+        vector<vector<PlainKey>> adjs = {{{2}}, {{3}}, {}};
+        Graph<int, PlainKey> G(keys, data, adjs);
+        if(G.get({2}) == nullptr || G.get({2})->data != 20) {
+            cout << "Incorrect result getting vertex 2 with a non-hashable key" << endl;
+        }
+        G.bfs({1});
+        if(G.get({3})->distance != 2) {
+            cout << "Incorrect bfs distance with a non-hashable key. Expected 2 but got : " << G.get({3})->distance << endl;
+        }
+        if(G.edge_class({1}, {2}) != "tree edge") {
+            cout << "Incorrect edge class with a non-hashable key. Expected tree edge but got : " << G.edge_class({1}, {2}) << endl;
+        }
+    } catch(exception& e) {
+        cerr << "Error testing non-hashable keys : " << e.what() << endl;
+    }
+}
+
+void test_external_graph() {
+    try {
+        // graph_description.txt with R..Y numbered 0..7, plus an isolated vertex 8; 3 vertices per block
+        vector<vector<uint32_t>> adjs = {{4}, {0}, {1, 3, 5}, {7}, {1}, {6}, {3}, {5}, {}};
+        ExternalGraphWriter writer("test_external.extgraph", adjs.size(), 3);
+        for(const vector<uint32_t>& adj : adjs) {
+            writer.add_adjacency(adj);
+        }
+        writer.finish();
+
+        ExternalGraph G("test_external.extgraph");
+        vector<int32_t> distance, predecessor;
+        int depth = G.bfs(2, distance, predecessor);
+        vector<int32_t> distances = {2, 1, 0, 1, 3, 1, 2, 2, -1};
+        if(depth != 3 || distance != distances || predecessor[4] != 0) {
+            cout << "Incorrect external bfs result from vertex \"T\" (2)" << endl;
+        }
 
-int main()
+        vector<uint32_t> component;
+        uint64_t components = G.connected_components(component);
+        if(components != 2 || component[7] != 0 || component[8] != 8) {
+            cout << "Incorrect external connected components. Expected 2 but got : " << components << endl;
+        }
+        if(G.block_count() != 3 || G.edge_count() != 10) {
+            cout << "Incorrect external graph layout. Expected 3 blocks and 10 edges" << endl;
+        }
+    } catch(exception& e) {
+        cerr << "Error testing external graph : " << e.what() << endl;
+    }
+
+    // Corrupt the file: the header ends at byte 32 and the 3-entry block table at 80, so block 0's
+    // first neighbour (after its 3 degrees) is at byte 92, and blockCount is at byte 28
+    uint32_t badNeighbour = 100;
+    fstream corrupt("test_external.extgraph", ios::binary | ios::in | ios::out);
+    corrupt.seekp(92);
+    corrupt.write((const char*)&badNeighbour, sizeof(badNeighbour));
+    corrupt.close();
+    try {
+        ExternalGraph G("test_external.extgraph");
+        vector<int32_t> distance, predecessor;
+        G.bfs(0, distance, predecessor);
+        cout << "External bfs did not reject a neighbour id out of range" << endl;
+    } catch(runtime_error& e) {
+    }
+
+    uint32_t badBlockCount = 5;
+    corrupt.open("test_external.extgraph", ios::binary | ios::in | ios::out);
+    corrupt.seekp(28);
+    corrupt.write((const char*)&badBlockCount, sizeof(badBlockCount));
+    corrupt.close();
+    try {
+        ExternalGraph G("test_external.extgraph");
+        cout << "External graph did not reject a block count that does not match its vertex count" << endl;
+    } catch(runtime_error& e) {
+    }
+
+    try {
+        ExternalGraphWriter writer("test_external.extgraph", (uint64_t)INT32_MAX + 1);
+        cout << "External graph writer accepted more vertices than bfs can index" << endl;
+    } catch(runtime_error& e) {
+    }
+    remove("test_external.extgraph");
+}
+
+//========================================================
+// Function: test_external_graph_large
+// Purpose: Runs the external BFS and connected components on a random graph far larger than the
+//          memory limit `make test_external` puts on the process (Graph<int,int> would need its
+//          Vertex objects and adjacency vectors on the heap). The file is streamed to disk and the
+//          results are checked edge by edge in another pass rather than against an in-memory copy.
+//========================================================
+
+void test_external_graph_large(uint32_t vertexCount) {
+    const uint32_t isolated = 1000;  // the last vertices have no edges in or out
+    try {
+        SplitRandom rng(7);
+        ExternalGraphWriter writer("test_external_large.extgraph", vertexCount);
+        vector<uint32_t> adj;
+        for(uint32_t u = 0; u < vertexCount; u++) {
+            adj.clear();
+            for(int i = 0; u < vertexCount - isolated && i < 4; i++) {
+                adj.push_back((uint32_t)rng.below(vertexCount - isolated));
+            }
+            writer.add_adjacency(adj);
+        }
+        writer.finish();
+
+        ExternalGraph G("test_external_large.extgraph");
+        vector<int32_t> distance, predecessor;
+        int depth = G.bfs(0, distance, predecessor);
+        if(G.scan_stats().passes != depth + 1) {
+            cout << "Incorrect external bfs passes. Expected " << depth + 1 << " but got : " << G.scan_stats().passes << endl;
+        }
+
+        // Every edge out of a reached vertex ends at most one level deeper, and every reached vertex
+        // other than the source hangs off a predecessor exactly one level up through a real edge
+        long long badEdges = 0;
+        vector<char> parentEdgeSeen(vertexCount, 0);
+        G.scan([&](uint32_t u, const uint32_t* neighbours, uint32_t degree) {
+            if(u != 0 && distance[u] != -1 && distance[predecessor[u]] != distance[u] - 1) {
+                badEdges++;
+            }
+            for(uint32_t i = 0; i < degree && distance[u] != -1; i++) {
+                if(distance[neighbours[i]] == -1 || distance[neighbours[i]] > distance[u] + 1) {
+                    badEdges++;
+                }
+                if(predecessor[neighbours[i]] == (int32_t)u) {
+                    parentEdgeSeen[neighbours[i]] = 1;
+                }
+            }
+        });
+        for(uint32_t v = 1; v < vertexCount; v++) {
+            if(distance[v] != -1 && !parentEdgeSeen[v]) {
+                badEdges++;
+            }
+        }
+        if(distance[0] != 0 || distance[vertexCount - 1] != -1 || badEdges != 0) {
+            cout << "Incorrect external bfs result on large graph : " << badEdges << " inconsistent edges" << endl;
+        }
+
+        vector<uint32_t> component;
+        uint64_t components = G.connected_components(component);
+        long long splitEdges = 0;
+        G.scan([&](uint32_t u, const uint32_t* neighbours, uint32_t degree) {
+            for(uint32_t i = 0; i < degree; i++) {
+                if(component[u] != component[neighbours[i]]) {
+                    splitEdges++;
+                }
+            }
+        });
+        if(components < isolated + 1 || component[vertexCount - 1] != vertexCount - 1 || splitEdges != 0) {
+            cout << "Incorrect external connected components on large graph : " << components << " components, "
+                 << splitEdges << " edges across components" << endl;
+        }
+    } catch(exception& e) {
+        cerr << "Error testing large external graph : " << e.what() << endl;
+    }
+    remove("test_external_large.extgraph");
+}
+
+int main(int argc, char** argv)
 {
+    // `./test external [vertices]` runs only the large external-memory test (see make test_external)
+    if (argc > 1 && string(argv[1]) == "external") {
+        test_external_graph_large(argc > 2 ? (uint32_t)atol(argv[2]) : 4000000);
+        cout << "Testing completed" << endl;
+        return 0;
+    }
+
     Graph<string, string> *G = generate_graph("graph_description.txt");
     Graph<int, int>* G_int = generate_graph_int("graph_description_unreachable_int.txt");
     test_get_int(G_int);
@@ -301,6 +591,12 @@ int main()
     // test_edge_class_int(G_int);
     test_bfs_tree(G);
     test_bfs_tree_int(G_int);
+    test_probe();
+    test_batch(G);
+    test_batch_int(G_int);
+    test_bfs_cache();
+    test_unhashable_key();
+    test_external_graph();
 
     cout << "Testing completed" << endl;
 
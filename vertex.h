@@ -14,16 +14,18 @@ public:
 
     DataType data;
     KeyType key;
-
-    struct BFSProperties {
-        int distance = 0;
-        bool visited = false;
-        Vertex<DataType, KeyType>* predecessor = nullptr;
-        int finishTime = 0;
-        vector<KeyType> adjacencyList;
-    };
-
-    BFSProperties bfsProps;
+    vector<KeyType> adj;  // change only through Graph::add_edge, which keeps the graph's caches valid
+
+    // BFS properties
+    bool color = false;
+    int distance = 0;
+    Vertex<DataType, KeyType>* p = nullptr;
+
+    // DFS properties
+    bool visited = false;
+    Vertex<DataType, KeyType>* predecessor = nullptr;
+    int discoveryTime = 0;
+    int finishingTime = 0;
 };
 
 #endif